@@ -0,0 +1,145 @@
+﻿#include "CompressedAutomaton.h"
+
+#include <set>
+#include <unordered_set>
+#include <algorithm>
+
+CompressedAutomaton::CompressedAutomaton(const std::vector<std::vector<std::pair<unsigned char, int>>>& rows, const std::vector<bool>& finalStates,
+    const std::vector<char>& alphabet)
+    : transitions(rows), finalStates(finalStates), alphabet(alphabet)
+{
+    this->finalStates.push_back(false);
+}
+
+bool CompressedAutomaton::AcceptsWord(const std::string& word) const
+{
+    const int deadState = transitions.GetDeadState();
+    int currentState = 0;
+    for (char symbol : word)
+    {
+        currentState = transitions.Next(currentState, (unsigned char)symbol);
+        if (currentState == deadState)
+            return false;
+    }
+
+    return finalStates[currentState];
+}
+
+/* Union-find over the states of both automata (Hopcroft-Karp): pairs reached by the same word are merged,
+   and only pairs whose classes were still apart are explored, so each merge is paid for once. */
+bool CompressedAutomaton::IsEquivalentTo(const CompressedAutomaton& other, std::string& counterexample) const
+{
+    const auto [symbols, thisTransitions, otherTransitions] = PairTransitions(other);
+
+    /* The states of the other automaton follow those of this one in the union-find. */
+    const int offset = (int)thisTransitions.size();
+    std::vector<int> parent(offset + otherTransitions.size());
+    for (int i = 0; i < parent.size(); i++)
+        parent[i] = i;
+
+    auto find = [&parent](int state)
+        {
+            while (parent[state] != state)
+                state = parent[state] = parent[parent[state]];
+            return state;
+        };
+
+    std::vector<ExploredPair> pairs = { { 0, 0, -1, '\0' } };
+    parent[offset] = 0;
+
+    for (int current = 0; current < pairs.size(); current++)
+    {
+        const auto [thisState, otherState, previous, symbol] = pairs[current];
+
+        if (finalStates[thisState] != other.finalStates[otherState])
+        {
+            counterexample = RebuildWord(pairs, current);
+            return false;
+        }
+
+        for (int k = 0; k < symbols.size(); k++)
+        {
+            int thisNext = thisTransitions[thisState][k];
+            int otherNext = otherTransitions[otherState][k];
+
+            int thisRoot = find(thisNext), otherRoot = find(offset + otherNext);
+            if (thisRoot != otherRoot)
+            {
+                parent[otherRoot] = thisRoot;
+                pairs.push_back({ thisNext, otherNext, current, symbols[k] });
+            }
+        }
+    }
+
+    return true;
+}
+
+/* Searches the product automaton, built only as far as it is reached, for a word accepted here and rejected by other. */
+bool CompressedAutomaton::IsIncludedIn(const CompressedAutomaton& other, std::string& counterexample) const
+{
+    const auto [symbols, thisTransitions, otherTransitions] = PairTransitions(other);
+
+    const int thisDeadState = (int)thisTransitions.size() - 1;
+    const long long otherStatesNumber = (long long)otherTransitions.size();
+
+    std::vector<ExploredPair> pairs = { { 0, 0, -1, '\0' } };
+    std::unordered_set<long long> visited = { 0 };
+
+    for (int current = 0; current < pairs.size(); current++)
+    {
+        const auto [thisState, otherState, previous, symbol] = pairs[current];
+
+        if (finalStates[thisState] && !other.finalStates[otherState])
+        {
+            counterexample = RebuildWord(pairs, current);
+            return false;
+        }
+
+        /* Nothing is accepted here past the dead state, so there is no counterexample beyond it. */
+        if (thisState == thisDeadState)
+            continue;
+
+        for (int k = 0; k < symbols.size(); k++)
+        {
+            int thisNext = thisTransitions[thisState][k];
+            int otherNext = otherTransitions[otherState][k];
+
+            if (visited.insert(thisNext * otherStatesNumber + otherNext).second)
+                pairs.push_back({ thisNext, otherNext, current, symbols[k] });
+        }
+    }
+
+    return true;
+}
+
+CompressedAutomaton::PairedTransitions CompressedAutomaton::PairTransitions(const CompressedAutomaton& other) const
+{
+    std::set<char> symbolsSet(alphabet.begin(), alphabet.end());
+    symbolsSet.insert(other.alphabet.begin(), other.alphabet.end());
+    std::vector<char> symbols(symbolsSet.begin(), symbolsSet.end());
+
+    return { symbols, IndexTransitions(symbols), other.IndexTransitions(symbols) };
+}
+
+std::vector<std::vector<int>> CompressedAutomaton::IndexTransitions(const std::vector<char>& symbols) const
+{
+    /* Dense form over the given symbols, for the checks that walk two automata side by side; the dead state keeps its row. */
+    const int deadState = transitions.GetDeadState();
+    std::vector<std::vector<int>> indexedTransitions(deadState + 1, std::vector<int>(symbols.size(), deadState));
+    for (int state = 0; state < deadState; state++)
+        for (int k = 0; k < symbols.size(); k++)
+            indexedTransitions[state][k] = transitions.Next(state, (unsigned char)symbols[k]);
+
+    return indexedTransitions;
+}
+
+/* The word that leads from the pair of initial states to pairs[last], read back along the previous links. */
+std::string CompressedAutomaton::RebuildWord(const std::vector<ExploredPair>& pairs, int last)
+{
+    std::string word;
+    for (int i = last; pairs[i].previous != -1; i = pairs[i].previous)
+        word += pairs[i].symbol;
+    std::reverse(word.begin(), word.end());
+
+    return word;
+}
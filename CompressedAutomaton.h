@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include "CompressedTransitionTable.h"
+
+/* Matching-only form of a DFA, made by DeterministicFiniteAutomaton::Compress: the packed transition table and a final
+   flag per state, state 0 being the initial one. It answers AcceptsWord, IsEquivalentTo and IsIncludedIn like the DFA it
+   comes from, in a fraction of the space, and offers nothing else. */
+class CompressedAutomaton
+{
+public:
+    CompressedAutomaton(const std::vector<std::vector<std::pair<unsigned char, int>>>& rows, const std::vector<bool>& finalStates,
+        const std::vector<char>& alphabet);
+
+    bool AcceptsWord(const std::string& word) const;
+    bool IsEquivalentTo(const CompressedAutomaton& other, std::string& counterexample) const;
+    bool IsIncludedIn(const CompressedAutomaton& other, std::string& counterexample) const;
+
+private:
+    /* Dense transitions of both automata over the union of their alphabets, for the checks that walk them side by side. */
+    struct PairedTransitions
+    {
+        std::vector<char> symbols;
+        std::vector<std::vector<int>> thisTransitions;
+        std::vector<std::vector<int>> otherTransitions;
+    };
+
+    /* A pair of states reached by both checks, with the pair and the symbol it was reached from. */
+    struct ExploredPair
+    {
+        int thisState;
+        int otherState;
+        int previous;
+        char symbol;
+    };
+
+    PairedTransitions PairTransitions(const CompressedAutomaton& other) const;
+    std::vector<std::vector<int>> IndexTransitions(const std::vector<char>& symbols) const;
+    static std::string RebuildWord(const std::vector<ExploredPair>& pairs, int last);
+
+    CompressedTransitionTable transitions;
+    /* One more than the states: the dead state, numbered last, is not final. */
+    std::vector<bool> finalStates;
+    std::vector<char> alphabet;
+};
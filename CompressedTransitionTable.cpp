@@ -0,0 +1,156 @@
+﻿#include "CompressedTransitionTable.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <map>
+
+static const int SymbolsNumber = 256;
+
+CompressedTransitionTable::CompressedTransitionTable(const std::vector<std::vector<std::pair<unsigned char, int>>>& rows)
+{
+    const int statesNumber = (int)rows.size();
+    const int deadState = statesNumber;
+
+    base.assign(statesNumber + 1, 0);
+    defaults.assign(statesNumber + 1, deadState);
+
+    /* Byte classes: the partition of the bytes is refined by each row, so two bytes stay together only if every state
+       sends them to the same target. A row only splits the classes of the bytes it has transitions on: those bytes move to
+       a new class per (class, target), except the group that is left holding all the bytes of its class. */
+    std::vector<int> classSizes = { SymbolsNumber };
+    for (const auto& row : rows)
+    {
+        std::map<std::pair<int, int>, std::vector<unsigned char>> groups;
+        for (const auto& [symbol, target] : row)
+            groups[{ byteClasses[symbol], target }].push_back(symbol);
+
+        for (const auto& [key, symbols] : groups)
+        {
+            const int byteClass = key.first;
+            if (symbols.size() == classSizes[byteClass])
+                continue;
+
+            classSizes[byteClass] -= (int)symbols.size();
+            for (unsigned char symbol : symbols)
+                byteClasses[symbol] = (std::uint8_t)classSizes.size();
+            classSizes.push_back((int)symbols.size());
+        }
+    }
+
+    /* No class is ever left empty, so there are at most 256; they are renumbered in the order of their first byte. */
+    std::vector<int> renumbered(classSizes.size(), -1);
+    int classesNumber = 0;
+    for (int byte = 0; byte < SymbolsNumber; byte++)
+    {
+        if (renumbered[byteClasses[byte]] == -1)
+            renumbered[byteClasses[byte]] = classesNumber++;
+        byteClasses[byte] = (std::uint8_t)renumbered[byteClasses[byte]];
+    }
+
+    /* From here on the columns are byte classes; all the bytes of a class have the same target, so any one of them will do.
+       The default of a state is the target of most of its columns, the columns without a transition going to the dead state;
+       every column with another target, the dead state included, is stored. */
+    std::vector<std::vector<std::pair<unsigned char, int>>> entries(statesNumber);
+    for (int state = 0; state < statesNumber; state++)
+    {
+        std::vector<int> classTargets(classesNumber, deadState);
+        for (const auto& [symbol, target] : rows[state])
+            classTargets[byteClasses[symbol]] = target;
+
+        std::unordered_map<int, int> targetsCount;
+        for (int target : classTargets)
+            targetsCount[target]++;
+
+        int defaultTarget = deadState;
+        int defaultCount = targetsCount[deadState];
+        for (const auto& [target, count] : targetsCount)
+            if (count > defaultCount)
+            {
+                defaultTarget = target;
+                defaultCount = count;
+            }
+
+        defaults[state] = defaultTarget;
+        for (int byteClass = 0; byteClass < classesNumber; byteClass++)
+            if (classTargets[byteClass] != defaultTarget)
+                entries[state].push_back({ (unsigned char)byteClass, classTargets[byteClass] });
+    }
+
+    /* First fit, densest rows first: each row is shifted to the first base where none of its entries collide.
+       Only the bases that put the first entry of the row on a free slot are tried; nextFree[slot] leads to the first free
+       slot at or after slot (union-find with path splitting), so a run of taken slots is skipped at once. */
+    std::vector<int> order(statesNumber);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&entries](int lhs, int rhs)
+        {
+            return entries[lhs].size() > entries[rhs].size();
+        });
+
+    auto fits = [this](const std::vector<std::pair<unsigned char, int>>& row, std::size_t candidate)
+        {
+            for (const auto& entry : row)
+                if (candidate + entry.first < check.size() && check[candidate + entry.first] != -1)
+                    return false;
+            return true;
+        };
+
+    std::vector<std::size_t> nextFree;
+    auto findFree = [&nextFree](std::size_t slot)
+        {
+            while (slot < nextFree.size() && nextFree[slot] != slot)
+            {
+                std::size_t following = nextFree[slot];
+                if (following < nextFree.size())
+                    nextFree[slot] = nextFree[following];
+                slot = following;
+            }
+            return slot;
+        };
+
+    for (int state : order)
+    {
+        if (entries[state].empty())
+            continue;
+
+        const std::size_t firstColumn = entries[state].front().first;
+        std::size_t candidate = findFree(firstColumn) - firstColumn;
+        while (!fits(entries[state], candidate))
+            candidate = findFree(candidate + 1 + firstColumn) - firstColumn;
+
+        base[state] = (std::int32_t)candidate;
+        if (check.size() < candidate + classesNumber)
+        {
+            check.resize(candidate + classesNumber, -1);
+            next.resize(candidate + classesNumber, deadState);
+            for (std::size_t slot = nextFree.size(); slot < check.size(); slot++)
+                nextFree.push_back(slot);
+        }
+
+        for (const auto& [symbol, target] : entries[state])
+        {
+            check[candidate + symbol] = state;
+            next[candidate + symbol] = target;
+            nextFree[candidate + symbol] = candidate + symbol + 1;
+        }
+    }
+
+    /* Padding to base + classesNumber - 1 for every row lets Next index without a bounds check. */
+    if (check.size() < classesNumber)
+    {
+        check.resize(classesNumber, -1);
+        next.resize(classesNumber, deadState);
+    }
+    check.shrink_to_fit();
+    next.shrink_to_fit();
+}
+
+bool CompressedTransitionTable::IsEmpty() const
+{
+    return base.empty();
+}
+
+int CompressedTransitionTable::GetDeadState() const
+{
+    return (int)base.size() - 1;
+}
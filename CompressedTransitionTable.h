@@ -0,0 +1,37 @@
+﻿#pragma once
+
+#include <vector>
+#include <array>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+/* Row displacement (comb) packing of a DFA transition function over bytes.
+   Bytes that behave the same in every state share a column (byte class), so a range such as the UTF-8 continuation
+   bytes 80-BF costs one entry per row. Every state keeps a default target (usually the dead state); only the
+   transitions that differ from it are stored, overlapped with the rows of the other states in one pair of next/check vectors:
+       index = base[state] + byteClasses[symbol]
+       Next(state, symbol) = check[index] == state ? next[index] : defaults[state]
+   States are numbered 0..statesNumber-1 and statesNumber is the dead state, which loops on itself. */
+class CompressedTransitionTable
+{
+public:
+    CompressedTransitionTable() = default;
+    CompressedTransitionTable(const std::vector<std::vector<std::pair<unsigned char, int>>>& rows);
+
+    int Next(int state, unsigned char symbol) const
+    {
+        std::size_t index = base[state] + byteClasses[symbol];
+        return check[index] == state ? next[index] : defaults[state];
+    }
+
+    bool IsEmpty() const;
+    int GetDeadState() const;
+
+private:
+    std::array<std::uint8_t, 256> byteClasses{};
+    std::vector<std::int32_t> base;
+    std::vector<std::int32_t> defaults;
+    std::vector<std::int32_t> next;
+    std::vector<std::int32_t> check;
+};
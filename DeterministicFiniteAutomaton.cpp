@@ -28,6 +28,12 @@ DeterministicFiniteAutomaton::DeterministicFiniteAutomaton(const LambdaNondeterm
     if (IsFinalState(statesMapping[initialState], lambdaAutomaton.GetFinalStates()))
         finalStates.insert(initialState);
 
+    /* Index from the (ordered) set of NFA states to its DFA state, so a subset is found without comparing it to every other one. */
+    std::map<std::set<std::string>, std::string> subsetsIndex;
+    subsetsIndex[{ statesMapping[initialState].begin(), statesMapping[initialState].end() }] = initialState;
+
+    std::vector<std::vector<char>> symbolGroups = lambdaAutomaton.GroupEquivalentSymbols();
+
     std::queue<std::string> unanalysedStates;
     unanalysedStates.push(initialState);
 
@@ -36,35 +42,37 @@ DeterministicFiniteAutomaton::DeterministicFiniteAutomaton(const LambdaNondeterm
         std::string currentState = unanalysedStates.front();
         unanalysedStates.pop();
 
-        for (char symbol : alphabet)
+        for (const std::vector<char>& symbols : symbolGroups)
         {
             std::unordered_set<std::string> newStateComponents = lambdaAutomaton.FindLambdaClosure(
-                lambdaAutomaton.FindTransition(statesMapping[currentState], symbol));
+                lambdaAutomaton.FindTransition(statesMapping[currentState], symbols.front()));
 
             if (newStateComponents.empty())
                 continue;
 
-            auto newStateIterator = find_if(statesMapping.begin(), statesMapping.end(), 
-                [newStateComponents](const auto& pair)
-                {
-                    return pair.second == newStateComponents;
-                });
+            std::set<std::string> newStateKey(newStateComponents.begin(), newStateComponents.end());
+            auto newStateIterator = subsetsIndex.find(newStateKey);
 
             std::string newState;
-            if (newStateIterator == statesMapping.end())
+            if (newStateIterator == subsetsIndex.end())
             {
+                if (statesNumber == MaxStatesNumber)
+                    throw std::length_error("Automat prea mare: depaseste " + std::to_string(MaxStatesNumber) + " de stari");
+
                 newState = "q" + std::to_string(statesNumber++) + "'";
                 states.insert(newState);
                 if (IsFinalState(newStateComponents, lambdaAutomaton.GetFinalStates()))
                     finalStates.insert(newState);
 
                 statesMapping.insert(std::make_pair(newState, newStateComponents));
+                subsetsIndex.insert(std::make_pair(std::move(newStateKey), newState));
                 unanalysedStates.push(newState);
             }
             else
-                newState = newStateIterator->first;
+                newState = newStateIterator->second;
             
-            transitionTable[std::make_pair(currentState, symbol)] = newState;
+            for (char symbol : symbols)
+                transitionTable[std::make_pair(currentState, symbol)] = newState;
         }
     }
 }
@@ -152,6 +160,48 @@ bool DeterministicFiniteAutomaton::CheckWord(const std::string& word) const
     return false;
 }
 
+bool DeterministicFiniteAutomaton::AcceptsWord(const std::string& word) const
+{
+    /* Same walk as CheckWord, without the step-by-step output, so it can be used when serving requests. */
+    std::string currentState = initialState;
+
+    for (char symbol : word) {
+        auto it = transitionTable.find({ currentState, symbol });
+        if (it == transitionTable.end())
+            return false;
+
+        currentState = it->second;
+    }
+
+    return finalStates.find(currentState) != finalStates.end();
+}
+
+CompressedAutomaton DeterministicFiniteAutomaton::Compress() const
+{
+    std::unordered_map<std::string, int> stateIndices = IndexStates();
+
+    std::vector<std::vector<std::pair<unsigned char, int>>> rows(stateIndices.size());
+    for (const auto& [key, target] : transitionTable)
+        rows[stateIndices[key.first]].push_back({ (unsigned char)key.second, stateIndices[target] });
+
+    std::vector<bool> indexedFinalStates(rows.size(), false);
+    for (const std::string& state : finalStates)
+        indexedFinalStates[stateIndices[state]] = true;
+
+    return CompressedAutomaton(rows, indexedFinalStates, std::vector<char>(alphabet.begin(), alphabet.end()));
+}
+
+/* Both checks run on the compressed forms, which number the states and give the missing transitions a dead state. */
+bool DeterministicFiniteAutomaton::IsEquivalentTo(const DeterministicFiniteAutomaton& other, std::string& counterexample) const
+{
+    return Compress().IsEquivalentTo(other.Compress(), counterexample);
+}
+
+bool DeterministicFiniteAutomaton::IsIncludedIn(const DeterministicFiniteAutomaton& other, std::string& counterexample) const
+{
+    return Compress().IsIncludedIn(other.Compress(), counterexample);
+}
+
 void DeterministicFiniteAutomaton::RunMenu(const std::string& regex) const
 {
     char key;
@@ -193,6 +243,165 @@ void DeterministicFiniteAutomaton::RunMenu(const std::string& regex) const
     } while (key != 'd');
 }
 
+bool DeterministicFiniteAutomaton::IsValidRegex(const std::string& regex, std::ostream& os)
+{
+    if (regex.empty())
+    {
+        os << "Regex vid.\n";
+        return false;
+    }
+
+    /* Character classes and UTF-8 characters are checked here and then stand as a single letter,
+       so the rest of the checks only see ASCII. operandSizes keeps, in order, how many byte transitions
+       each letter of the skeleton stands for. */
+    std::string skeleton;
+    std::vector<long long> operandSizes;
+    bool insideBraces = false;
+    for (size_t i = 0; i < regex.size(); i++)
+    {
+        std::vector<Utf8Ranges::CodePointRange> ranges;
+        char32_t codePoint;
+        size_t position = i;
+
+        if (regex[i] == '[')
+        {
+            size_t closing = regex.find(']', i);
+            if (closing == std::string::npos || !Utf8Ranges::ParseCharacterClass(regex.substr(i + 1, closing - i - 1), ranges))
+            {
+                os << "Clasa de caractere invalida.\n";
+                return false;
+            }
+            skeleton += 'a';
+            i = closing;
+
+            long long classSize = 0;
+            for (const auto& sequence : Utf8Ranges::ToByteSequences(ranges))
+                classSize += sequence.size();
+            operandSizes.push_back(classSize);
+        }
+        else if ((unsigned char)regex[i] >= 0x80)
+        {
+            if (!Utf8Ranges::DecodeCodePoint(regex, position, codePoint))
+            {
+                os << "Caracter UTF-8 invalid.\n";
+                return false;
+            }
+            skeleton += 'a';
+            operandSizes.push_back(position - i);
+            i = position - 1;
+        }
+        else
+        {
+            skeleton += regex[i];
+            insideBraces = regex[i] == '{' || (insideBraces && regex[i] != '}');
+            if (isalnum(regex[i]) && !insideBraces)
+                operandSizes.push_back(1);
+        }
+    }
+
+    /* The syntax is checked in one pass, without recursing on the nesting, so a deeply nested expression cannot exhaust
+       the stack: after an operand (afterOperand) may come a postfix operator (* + {m,n}), a binary one (. |) or a ')';
+       anywhere else an operand or a '(' is expected. */
+    int depth = 0;
+    bool afterOperand = false;
+    for(int i = 0; i < skeleton.size(); i++)
+    {
+        char ch = skeleton[i];
+        bool valid;
+        if (ch == '{')
+        {
+            /* Counted repetition {m}, {m,} or {m,n}, applied to the operand before it. */
+            size_t closing = skeleton.find('}', i);
+            int minimum, maximum;
+            valid = afterOperand && closing != std::string::npos &&
+                LambdaNondeterministicAutomaton::ParseRepetitionBounds(skeleton.substr(i + 1, closing - i - 1), minimum, maximum);
+            i = (int)closing;
+        }
+        else if (isalnum(ch) || ch == '(')
+        {
+            valid = !afterOperand;
+            afterOperand = ch != '(';
+            depth += ch == '(';
+        }
+        else if (ch == '*' || ch == '+')
+            valid = afterOperand;
+        else if (ch == '.' || ch == '|')
+        {
+            valid = afterOperand;
+            afterOperand = false;
+        }
+        else if (ch == ')')
+            valid = afterOperand && depth-- > 0;
+        else
+            valid = false;
+
+        if (!valid)
+        {
+            os << "Expresie invalida.\n";
+            return false;
+        }
+    }
+
+    if (!afterOperand || depth != 0)
+    {
+        os << "Expresie invalida.\n";
+        return false;
+    }
+
+    /* Every operator must find its operands, otherwise building the automaton would pop from an empty stack.
+       Alongside, sizes follows the size of the lambda-NFA of each operand: a counted repetition copies its operand once per
+       repetition, so nested ones multiply, and the whole expansion is bounded before anything is built. */
+    std::vector<long long> sizes;
+    size_t nextOperand = 0;
+    std::string postfix = ConvertToPostfix(skeleton);
+    for (int i = 0; i < postfix.size(); i++)
+    {
+        char ch = postfix[i];
+        int minimum = 0, maximum = 0;
+        if (ch == '{')
+        {
+            size_t closing = postfix.find('}', i);
+            LambdaNondeterministicAutomaton::ParseRepetitionBounds(postfix.substr(i + 1, closing - i - 1), minimum, maximum);
+            i = (int)closing;
+        }
+
+        int arity = isalnum(ch) ? 0 : (ch == '.' || ch == '|' ? 2 : 1);
+        if (sizes.size() < arity)
+        {
+            os << "Expresie invalida.\n";
+            return false;
+        }
+
+        if (arity == 0)
+            sizes.push_back(operandSizes[nextOperand++]);
+        else if (arity == 2)
+        {
+            long long rightSize = sizes.back();
+            sizes.pop_back();
+            sizes.back() += rightSize + 1;
+        }
+        else if (ch == '{')
+            sizes.back() = sizes.back() * std::max(maximum == -1 ? minimum : maximum, 1) + 1;
+        else
+            sizes.back()++;
+
+        if (sizes.back() > LambdaNondeterministicAutomaton::MaxExpandedSize)
+        {
+            os << "Expresie prea mare: depaseste " << LambdaNondeterministicAutomaton::MaxExpandedSize
+                << " tranzitii dupa expandarea repetitiilor.\n";
+            return false;
+        }
+    }
+
+    if (sizes.size() != 1)
+    {
+        os << "Expresie invalida.\n";
+        return false;
+    }
+
+    return true;
+}
+
 std::string DeterministicFiniteAutomaton::ConvertToPostfix(const std::string& regex)
 {
     std::string postfix;
@@ -205,10 +414,29 @@ std::string DeterministicFiniteAutomaton::ConvertToPostfix(const std::string& re
         {'|', 1} 
     };
 
-    for (char ch : regex) {
-        if (std::isalnum(ch)) {
+    for (int i = 0; i < regex.size(); i++) {
+        char ch = regex[i];
+        if ((unsigned char)ch >= 0x80) {
+            postfix += ch;  // octet al unui caracter UTF-8, operand ca si caracterele alfanumerice
+        }
+        else if (ch == '[') {
+            size_t closing = regex.find(']', i);
+            postfix += regex.substr(i, closing - i + 1);
+            i = (int)closing;
+        }
+        else if (std::isalnum(ch)) {
             postfix += ch;  
         }
+        else if (ch == '{') {
+            /* A counted repetition binds like * and +, so it is written out, bounds included, right after its operand. */
+            while (!operators.empty() && priority[operators.top()] >= priority['*']) {
+                postfix += operators.top();
+                operators.pop();
+            }
+            size_t closing = regex.find('}', i);
+            postfix += regex.substr(i, closing - i + 1);
+            i = (int)closing;
+        }
         else if (ch == '(') {
             operators.push(ch);
         }
@@ -251,6 +479,15 @@ bool DeterministicFiniteAutomaton::IsFinalState(std::unordered_set<std::string>
     return false;
 }
 
+std::unordered_map<std::string, int> DeterministicFiniteAutomaton::IndexStates() const
+{
+    std::unordered_map<std::string, int> stateIndices = { { initialState, 0 } };
+    for (const std::string& state : states)
+        stateIndices.insert({ state, (int)stateIndices.size() });
+
+    return stateIndices;
+}
+
 void DeterministicFiniteAutomaton::Print() const
 {
     std::cout << *this << '\n';
@@ -270,7 +507,7 @@ std::ostream& operator<<(std::ostream& os, const DeterministicFiniteAutomaton& a
 
     os << "Alfabet: ";
     for (const auto& symbol : automaton.alphabet) {
-        os << symbol << " ";
+        os << Utf8Ranges::FormatSymbol(symbol) << " ";
     }
     os << "\n";
 
@@ -282,7 +519,7 @@ std::ostream& operator<<(std::ostream& os, const DeterministicFiniteAutomaton& a
         const auto& state = key.first;
         const auto& symbol = key.second;
 
-        os << state << " -" << (symbol == '\0' ? "$" : std::string(1, symbol)) << "-> " << value << "\n";
+        os << state << " -" << Utf8Ranges::FormatSymbol(symbol) << "-> " << value << "\n";
     }
 
     os << "Starea initiala: " << automaton.initialState << "\n";
@@ -7,8 +7,13 @@
 #include <set>
 #include <string>
 #include <stack>
+#include <vector>
 #include <utility>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
 #include "LambdaNondeterministicAutomaton.h"
+#include "CompressedAutomaton.h"
 
 /*struct PairHash {
     template <typename T1, typename T2>
@@ -44,16 +49,26 @@ public:
 
     bool VerifyAutomaton() const;
     bool CheckWord(const std::string& word) const;
+    bool AcceptsWord(const std::string& word) const;
+    CompressedAutomaton Compress() const;
+    bool IsEquivalentTo(const DeterministicFiniteAutomaton& other, std::string& counterexample) const;
+    bool IsIncludedIn(const DeterministicFiniteAutomaton& other, std::string& counterexample) const;
     void RunMenu(const std::string& regex) const;
 
+    static bool IsValidRegex(const std::string& regex, std::ostream& os = std::cout);
     static std::string ConvertToPostfix(const std::string& regex);
     static DeterministicFiniteAutomaton BuildDFA(const std::string& postfixRegex);
 
     friend std::ostream& operator<<(std::ostream& os, const DeterministicFiniteAutomaton& automaton);
 
+    /* Bound on the states made by the subset construction (and by the product of a RuleSet); past it the construction
+       stops with std::length_error, since an expression such as (a|b)*.a.(a|b){n} needs 2^(n+1) of them. */
+    static const int MaxStatesNumber = 5000;
+
 private:
     bool IsFinalState(std::unordered_set<std::string> stateComponents, std::unordered_set<std::string> lambdaAutomatonFinalStates);
     void Print() const;
+    std::unordered_map<std::string, int> IndexStates() const;
 
     std::unordered_set<std::string> states;
     std::unordered_set<std::string> finalStates;
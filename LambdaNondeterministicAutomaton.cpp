@@ -129,6 +129,139 @@ LambdaNondeterministicAutomaton LambdaNondeterministicAutomaton::KleenePlus(cons
     return result;
 }
 
+LambdaNondeterministicAutomaton LambdaNondeterministicAutomaton::Repetition(const LambdaNondeterministicAutomaton& A, int minimum, int maximum, int& stateCounter)
+{
+    LambdaNondeterministicAutomaton result;
+
+    std::string newInitialState = "q" + std::to_string(stateCounter++);
+    std::string newFinalState = "q" + std::to_string(stateCounter++);
+
+    result.states.insert(newInitialState);
+    result.states.insert(newFinalState);
+
+    /* Copies of A are chained by lambda-transitions, and every copy from the minimum-th on may also jump to the final state.
+       For an unbounded repetition the last copy loops back on itself, so A{m,} needs only m copies. */
+    const int copiesNumber = maximum == -1 ? std::max(minimum, 1) : maximum;
+    std::unordered_set<std::string> previousFinalStates = { newInitialState };
+
+    for (int i = 0; i <= copiesNumber; i++)
+    {
+        if (i >= minimum)
+            for (const auto& state : previousFinalStates)
+                result.transitionTable[{state, '\0'}].insert(newFinalState);
+
+        if (i == copiesNumber)
+            break;
+
+        /* The first copy reuses the states of A, the others get fresh names. */
+        LambdaNondeterministicAutomaton copy = i == 0 ? A : Copy(A, stateCounter);
+
+        result.states.insert(copy.states.begin(), copy.states.end());
+        result.transitionTable.insert(copy.transitionTable.begin(), copy.transitionTable.end());
+
+        for (const auto& state : previousFinalStates)
+            result.transitionTable[{state, '\0'}].insert(copy.initialState);
+
+        if (maximum == -1 && i == copiesNumber - 1)
+            for (const auto& state : copy.finalStates)
+                result.transitionTable[{state, '\0'}].insert(copy.initialState);
+
+        previousFinalStates = copy.finalStates;
+    }
+
+    result.initialState = newInitialState;
+    result.finalStates = { newFinalState };
+
+    result.alphabet = A.alphabet;
+
+    return result;
+}
+
+LambdaNondeterministicAutomaton LambdaNondeterministicAutomaton::CharacterClass(const std::vector<Utf8Ranges::CodePointRange>& ranges, int& stateCounter)
+{
+    LambdaNondeterministicAutomaton result;
+
+    std::string startState = "q" + std::to_string(stateCounter++);
+    std::string endState = "q" + std::to_string(stateCounter++);
+
+    result.states = { startState, endState };
+
+    /* Every UTF-8 byte sequence of the class is built from its last byte range backwards, and a state is shared by all the
+       sequences that continue with the same byte range into the same state, so common suffixes (the 80-BF tails) exist once. */
+    std::map<std::pair<Utf8Ranges::ByteRange, std::string>, std::string> suffixStates;
+    for (const auto& sequence : Utf8Ranges::ToByteSequences(ranges)) {
+        std::string target = endState;
+        for (size_t k = sequence.size() - 1; k > 0; k--) {
+            auto [it, inserted] = suffixStates.insert({ { sequence[k], target }, "" });
+            if (inserted) {
+                it->second = "q" + std::to_string(stateCounter++);
+                result.states.insert(it->second);
+                for (int byte = sequence[k].first; byte <= sequence[k].second; byte++) {
+                    result.transitionTable[{it->second, (char)byte}].insert(target);
+                    result.alphabet.insert((char)byte);
+                }
+            }
+            target = it->second;
+        }
+
+        for (int byte = sequence[0].first; byte <= sequence[0].second; byte++) {
+            result.transitionTable[{startState, (char)byte}].insert(target);
+            result.alphabet.insert((char)byte);
+        }
+    }
+
+    result.initialState = startState;
+    result.finalStates = { endState };
+
+    return result;
+}
+
+LambdaNondeterministicAutomaton LambdaNondeterministicAutomaton::Copy(const LambdaNondeterministicAutomaton& A, int& stateCounter)
+{
+    LambdaNondeterministicAutomaton result;
+
+    std::unordered_map<std::string, std::string> renamedStates;
+    for (const auto& state : A.states) {
+        renamedStates[state] = "q" + std::to_string(stateCounter++);
+        result.states.insert(renamedStates[state]);
+    }
+
+    for (const auto& [key, targets] : A.transitionTable) {
+        auto& renamedTargets = result.transitionTable[{renamedStates[key.first], key.second}];
+        for (const auto& target : targets)
+            renamedTargets.insert(renamedStates[target]);
+    }
+
+    result.initialState = renamedStates[A.initialState];
+    for (const auto& state : A.finalStates)
+        result.finalStates.insert(renamedStates[state]);
+
+    result.alphabet = A.alphabet;
+
+    return result;
+}
+
+bool LambdaNondeterministicAutomaton::ParseRepetitionBounds(const std::string& bounds, int& minimum, int& maximum)
+{
+    /* The text between the braces of {m}, {m,} or {m,n}; maximum is -1 when there is no upper bound. */
+    size_t comma = bounds.find(',');
+    std::string minimumText = bounds.substr(0, comma);
+    std::string maximumText = comma == std::string::npos ? minimumText : bounds.substr(comma + 1);
+
+    auto isNumber = [](const std::string& text)
+        {
+            return !text.empty() && text.size() <= 4 && text.find_first_not_of("0123456789") == std::string::npos;
+        };
+
+    if (!isNumber(minimumText) || (!maximumText.empty() && !isNumber(maximumText)))
+        return false;
+
+    minimum = std::stoi(minimumText);
+    maximum = maximumText.empty() ? -1 : std::stoi(maximumText);
+
+    return minimum <= MaxRepetition && maximum <= MaxRepetition && (maximum == -1 || minimum <= maximum);
+}
+
 const std::unordered_set<char>& LambdaNondeterministicAutomaton::GetAlphabet() const
 {
     return alphabet;
@@ -158,10 +291,8 @@ std::unordered_set<std::string> LambdaNondeterministicAutomaton::FindLambdaClosu
 
         if(auto it = transitionTable.find(std::make_pair(currentState, '\0')); it != transitionTable.end())
             for (const std::string& state : it->second)
-            {
-                lambdaClosure.insert(state);
-                unanalysedStates.push(state);
-            }
+                if (lambdaClosure.insert(state).second)
+                    unanalysedStates.push(state);
     }
     
     return lambdaClosure;
@@ -178,6 +309,29 @@ std::unordered_set<std::string> LambdaNondeterministicAutomaton::FindTransition(
     return transition;
 }
 
+std::vector<std::vector<char>> LambdaNondeterministicAutomaton::GroupEquivalentSymbols() const
+{
+    /* Symbols with the same transitions in every state (e.g. the bytes of one range of a character class) lead to the
+       same subsets, so the subset construction follows only one symbol of each group. */
+    std::unordered_map<char, std::vector<std::pair<std::string, std::set<std::string>>>> signatures;
+    for (const auto& [key, targets] : transitionTable)
+        if (key.second != '\0')
+            signatures[key.second].push_back({ key.first, std::set<std::string>(targets.begin(), targets.end()) });
+
+    std::map<std::vector<std::pair<std::string, std::set<std::string>>>, std::vector<char>> groups;
+    for (char symbol : alphabet) {
+        auto& signature = signatures[symbol];
+        std::sort(signature.begin(), signature.end());
+        groups[signature].push_back(symbol);
+    }
+
+    std::vector<std::vector<char>> symbolGroups;
+    for (const auto& [signature, symbols] : groups)
+        symbolGroups.push_back(symbols);
+
+    return symbolGroups;
+}
+
 LambdaNondeterministicAutomaton LambdaNondeterministicAutomaton::BuildLambdaNFA(const std::string& postfixRegex)
 {
     std::stack<LambdaNondeterministicAutomaton> stack;
@@ -185,8 +339,27 @@ LambdaNondeterministicAutomaton LambdaNondeterministicAutomaton::BuildLambdaNFA(
 
     //std::cout << "Construim AFN din expresia regulata: " << postfixRegex << "\n";
 
-    for (char symbol : postfixRegex) {
-        if (isalnum(symbol)) {
+    for (int i = 0; i < postfixRegex.size(); i++) {
+        char symbol = postfixRegex[i];
+        if ((unsigned char)symbol >= 0x80 || symbol == '[') {
+            // Clasa de caractere sau caracter Unicode, compilate in secvente de octeti UTF-8
+            std::vector<Utf8Ranges::CodePointRange> ranges;
+            if (symbol == '[') {
+                size_t closing = postfixRegex.find(']', i);
+                Utf8Ranges::ParseCharacterClass(postfixRegex.substr(i + 1, closing - i - 1), ranges);
+                i = closing;
+            }
+            else {
+                size_t position = i;
+                char32_t codePoint;
+                Utf8Ranges::DecodeCodePoint(postfixRegex, position, codePoint);
+                ranges = { { codePoint, codePoint } };
+                i = position - 1;
+            }
+
+            stack.push(CharacterClass(ranges, stateCounter));
+        }
+        else if (isalnum(symbol)) {
             // Automat pentru un simbol
             LambdaNondeterministicAutomaton simpleAutomaton;
             std::string startState = "q" + std::to_string(stateCounter++);
@@ -254,6 +427,18 @@ LambdaNondeterministicAutomaton LambdaNondeterministicAutomaton::BuildLambdaNFA(
             auto kleenePlusAutomaton = KleenePlus(A, stateCounter);
             stack.push(kleenePlusAutomaton);
         }
+        else if (symbol == '{')
+        {
+            // Repetare numarata {m}, {m,} sau {m,n}
+            size_t closing = postfixRegex.find('}', i);
+            int minimum, maximum;
+            ParseRepetitionBounds(postfixRegex.substr(i + 1, closing - i - 1), minimum, maximum);
+            i = closing;
+
+            LambdaNondeterministicAutomaton A = stack.top(); stack.pop();
+            auto repeatedAutomaton = Repetition(A, minimum, maximum, stateCounter);
+            stack.push(repeatedAutomaton);
+        }
 
         //std::cout << "Valoarea contorului dupa procesare: " << stateCounter << "\n";
     }
@@ -277,7 +462,7 @@ std::ostream& operator<<(std::ostream& os, const LambdaNondeterministicAutomaton
 
     os << "Alfabet: ";
     for (const auto& symbol : automaton.alphabet) {
-        os << symbol << " ";
+        os << Utf8Ranges::FormatSymbol(symbol) << " ";
     }
     os << "\n";
 
@@ -290,7 +475,7 @@ std::ostream& operator<<(std::ostream& os, const LambdaNondeterministicAutomaton
         const auto& symbol = key.second;
 
         for(const std::string& value : values)
-            os << state << " -" << (symbol == '\0' ? "$" : std::string(1, symbol)) << "-> " << value << "\n";
+            os << state << " -" << Utf8Ranges::FormatSymbol(symbol) << "-> " << value << "\n";
     }
 
     os << "Starea initiala: " << automaton.initialState << "\n";
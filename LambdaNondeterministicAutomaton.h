@@ -6,6 +6,11 @@
 #include <stack>
 #include <queue>
 #include <iostream>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+#include "Utf8Ranges.h"
 
 struct pair_hash
 {
@@ -30,13 +35,22 @@ public:
 
 	std::unordered_set<std::string> FindLambdaClosure(const std::unordered_set<std::string>& states) const;
 	std::unordered_set<std::string> FindTransition(const std::unordered_set<std::string>& states, char symbol) const;
+	std::vector<std::vector<char>> GroupEquivalentSymbols() const;
 
 	static LambdaNondeterministicAutomaton BuildLambdaNFA(const std::string& postfixRegex);
+	static bool ParseRepetitionBounds(const std::string& bounds, int& minimum, int& maximum);
+
+	static const int MaxRepetition = 1000;
+	/* Bound on the byte transitions of an expression once its counted repetitions are copied out (nested bounds multiply). */
+	static const int MaxExpandedSize = 25000;
 private:
 	static LambdaNondeterministicAutomaton Alternation(const LambdaNondeterministicAutomaton& A, const LambdaNondeterministicAutomaton& B, int& stateCounter);
 	static LambdaNondeterministicAutomaton Concatenation(const LambdaNondeterministicAutomaton& A, const LambdaNondeterministicAutomaton& B, int& stateCounter);
 	static LambdaNondeterministicAutomaton KleeneStar(const LambdaNondeterministicAutomaton& A, int& stateCounter);
 	static LambdaNondeterministicAutomaton KleenePlus(const LambdaNondeterministicAutomaton& A, int& stateCounter);
+	static LambdaNondeterministicAutomaton Repetition(const LambdaNondeterministicAutomaton& A, int minimum, int maximum, int& stateCounter);
+	static LambdaNondeterministicAutomaton CharacterClass(const std::vector<Utf8Ranges::CodePointRange>& ranges, int& stateCounter);
+	static LambdaNondeterministicAutomaton Copy(const LambdaNondeterministicAutomaton& A, int& stateCounter);
 
 	friend std::ostream& operator<<(std::ostream& os, const LambdaNondeterministicAutomaton& automaton);
 
@@ -0,0 +1,675 @@
+﻿#include "MatchServer.h"
+
+#include <sstream>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef _WIN32
+static const SocketHandle InvalidSocket = INVALID_SOCKET;
+static const int SendFlags = 0;
+#else
+static const SocketHandle InvalidSocket = -1;
+static const int SendFlags = MSG_NOSIGNAL;
+#endif
+
+/* A client that sends this much without a newline is disconnected instead of being buffered forever;
+   past this much unanswered input or unsent output, a connection is not read until it catches up. */
+static const size_t MaxRequestLength = 1 << 20;
+
+/* A connection with no request in progress and nothing received for this long is closed. */
+static const std::chrono::seconds IdleTimeout(60);
+
+/* After a failed accept (too many open files, for example) the listener is left alone for this long instead of being retried at once. */
+static const std::chrono::seconds AcceptRetryDelay(1);
+
+static void CloseSocket(SocketHandle socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+static bool SetNonBlocking(SocketHandle socket)
+{
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool WouldBlock()
+{
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+/* Words travel with every byte that is not printable ASCII, \ and $ written as \xHH, so a word is always one
+   whitespace-free token; a lone $ is the empty word. */
+static std::string EscapeWord(const std::string& word)
+{
+    if (word.empty())
+        return "$";
+
+    static const char digits[] = "0123456789ABCDEF";
+    std::string escaped;
+    for (unsigned char byte : word)
+        if (byte > 0x20 && byte < 0x7F && byte != '\\' && byte != '$')
+            escaped += (char)byte;
+        else
+            escaped += std::string("\\x") + digits[byte >> 4] + digits[byte & 0xF];
+
+    return escaped;
+}
+
+static bool UnescapeWord(const std::string& text, std::string& word)
+{
+    word.clear();
+    if (text == "$")
+        return true;
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        if (text[i] != '\\')
+        {
+            word += text[i];
+            continue;
+        }
+
+        if (i + 3 >= text.size() || text[i + 1] != 'x' ||
+            !std::isxdigit((unsigned char)text[i + 2]) || !std::isxdigit((unsigned char)text[i + 3]))
+            return false;
+
+        word += (char)std::stoi(text.substr(i + 2, 2), nullptr, 16);
+        i += 3;
+    }
+
+    return true;
+}
+
+static int PollSockets(std::vector<pollfd>& descriptors, int timeout)
+{
+#ifdef _WIN32
+    return WSAPoll(descriptors.data(), (ULONG)descriptors.size(), timeout);
+#else
+    return poll(descriptors.data(), descriptors.size(), timeout);
+#endif
+}
+
+MatchServer::MatchServer(const std::string& socketPath, unsigned threadsNumber)
+    : socketPath(socketPath), threadsNumber(threadsNumber == 0 ? 1 : threadsNumber), listener(InvalidSocket), running(false),
+    stopRequested(false), wakeSender(InvalidSocket), wakeReceiver(InvalidSocket), workersRunning(false) {}
+
+MatchServer::~MatchServer()
+{
+    Stop();
+}
+
+bool MatchServer::Run()
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        std::cout << "Winsock nu a putut fi initializat.\n";
+        return false;
+    }
+#endif
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "Calea socketului este invalida: " << socketPath << "\n";
+        return false;
+    }
+    socketPath.copy(address.sun_path, socketPath.size());
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == InvalidSocket)
+    {
+        std::cout << "Socketul nu a putut fi creat.\n";
+        return false;
+    }
+
+    /* A socket file left behind by a previous run would make bind fail. */
+    std::error_code error;
+    std::filesystem::remove(socketPath, error);
+
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0)
+    {
+        std::cout << "Serverul nu poate asculta pe " << socketPath << ".\n";
+        CloseSocket(listener);
+        listener = InvalidSocket;
+        return false;
+    }
+
+    /* The wake-up pair is a connection to the server itself, which works the same way on every platform. */
+    wakeSender = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (wakeSender == InvalidSocket || connect(wakeSender, (sockaddr*)&address, sizeof(address)) != 0 ||
+        (wakeReceiver = accept(listener, nullptr, nullptr)) == InvalidSocket ||
+        !SetNonBlocking(wakeSender) || !SetNonBlocking(wakeReceiver) || !SetNonBlocking(listener))
+    {
+        std::cout << "Serverul nu poate asculta pe " << socketPath << ".\n";
+        CloseConnections();
+        return false;
+    }
+
+    workersRunning = true;
+    for (unsigned i = 0; i < threadsNumber; i++)
+        workers.emplace_back(&MatchServer::WorkerLoop, this);
+
+    running = true;
+    if (stopRequested)
+        running = false;
+    std::cout << "Serverul asculta pe " << socketPath << " (" << threadsNumber << " fire de executie).\n";
+
+    std::vector<pollfd> descriptors;
+    while (running)
+    {
+        descriptors.clear();
+        descriptors.push_back({ wakeReceiver, POLLIN, 0 });
+        descriptors.push_back({ listener, (short)(std::chrono::steady_clock::now() >= acceptPausedUntil ? POLLIN : 0), 0 });
+        for (const auto& [client, connection] : connections)
+        {
+            short events = 0;
+            if (!connection.inputClosed && (connection.discarding ||
+                (connection.input.size() <= MaxRequestLength && connection.output.size() <= MaxRequestLength)))
+                events |= POLLIN;
+            if (!connection.output.empty())
+                events |= POLLOUT;
+
+            /* A connection waiting only for its job is left out, or a hang-up would wake the poll over and over. */
+            if (events != 0)
+                descriptors.push_back({ client, events, 0 });
+        }
+
+        /* The timeout only bounds how late idle connections are noticed. */
+        if (PollSockets(descriptors, 1000) < 0)
+            continue;
+
+        if (descriptors[0].revents != 0)
+        {
+            char buffer[256];
+            while ((int)recv(wakeReceiver, buffer, sizeof(buffer), 0) > 0);
+        }
+
+        CollectResults();
+
+        if (descriptors[1].revents & POLLIN)
+            AcceptClients();
+
+        for (size_t i = 2; i < descriptors.size(); i++)
+        {
+            auto it = connections.find(descriptors[i].fd);
+            if (descriptors[i].revents & (POLLIN | POLLHUP | POLLERR))
+                ReadClient(it->first, it->second);
+            if (descriptors[i].revents & POLLOUT)
+                WriteClient(it->first, it->second);
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = connections.begin(); it != connections.end();)
+        {
+            auto& [client, connection] = *it;
+            if (!connection.busy && !connection.failed && connection.output.size() <= MaxRequestLength)
+                DispatchJob(client, connection);
+
+            if (!connection.busy && connection.tooLong)
+            {
+                connection.output += "ERR Cerere prea lunga\n";
+                connection.tooLong = false;
+                WriteClient(client, connection);
+            }
+
+            bool finished = connection.inputClosed && connection.output.empty() && connection.input.find('\n') == std::string::npos;
+            bool idle = connection.output.empty() && now - connection.lastActivity > IdleTimeout;
+            if (!connection.busy && (connection.failed || finished || idle))
+            {
+                CloseSocket(client);
+                it = connections.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        workersRunning = false;
+    }
+    jobsCondition.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+
+    pendingJobs = {};
+    completedJobs.clear();
+    CloseConnections();
+
+    std::cout << "Serverul s-a oprit.\n";
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    return true;
+}
+
+void MatchServer::Stop()
+{
+    /* Only atomic stores and a send, so Stop may be called from a signal handler. */
+    stopRequested = true;
+    if (running.exchange(false))
+        Wake();
+}
+
+void MatchServer::Wake()
+{
+    /* A full buffer means a wake-up is already pending, so a failed send is not an error. */
+    char signal = 0;
+    send(wakeSender, &signal, 1, SendFlags);
+}
+
+void MatchServer::WorkerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsCondition.wait(lock, [this] { return !pendingJobs.empty() || !workersRunning; });
+            if (!workersRunning)
+                return;
+
+            job = std::move(pendingJobs.front());
+            pendingJobs.pop();
+        }
+
+        for (const std::string& request : job.requests)
+            job.responses += HandleRequest(request) + "\n";
+
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            completedJobs.push_back(std::move(job));
+        }
+        Wake();
+    }
+}
+
+void MatchServer::AcceptClients()
+{
+    while (true)
+    {
+        SocketHandle client = accept(listener, nullptr, nullptr);
+        if (client == InvalidSocket)
+        {
+            if (!WouldBlock())
+            {
+                std::cout << "Conexiunea nu a putut fi acceptata, se reincearca peste " << AcceptRetryDelay.count() << " s.\n";
+                acceptPausedUntil = std::chrono::steady_clock::now() + AcceptRetryDelay;
+            }
+            return;
+        }
+
+        if (!SetNonBlocking(client))
+        {
+            CloseSocket(client);
+            continue;
+        }
+
+        connections[client].lastActivity = std::chrono::steady_clock::now();
+    }
+}
+
+void MatchServer::ReadClient(SocketHandle client, Connection& connection)
+{
+    if (connection.inputClosed)
+        return;
+
+    char buffer[4096];
+    int received = (int)recv(client, buffer, sizeof(buffer), 0);
+    if (received < 0 && WouldBlock())
+        return;
+
+    if (received <= 0)
+    {
+        /* The requests already received are still answered; the connection is closed once they are sent. */
+        connection.inputClosed = true;
+        return;
+    }
+
+    /* Closing a socket with unread data would reset the connection and lose the error, so the rest is read and dropped. */
+    if (connection.discarding)
+        return;
+
+    connection.input.append(buffer, received);
+    connection.lastActivity = std::chrono::steady_clock::now();
+
+    size_t lastLineEnd = connection.input.rfind('\n');
+    size_t incompleteLength = connection.input.size() - (lastLineEnd == std::string::npos ? 0 : lastLineEnd + 1);
+    if (incompleteLength > MaxRequestLength)
+    {
+        connection.input.resize(connection.input.size() - incompleteLength);
+        connection.discarding = true;
+        connection.tooLong = true;
+    }
+}
+
+void MatchServer::WriteClient(SocketHandle client, Connection& connection)
+{
+    while (!connection.output.empty())
+    {
+        int sent = (int)send(client, connection.output.data(), (int)connection.output.size(), SendFlags);
+        if (sent < 0 && WouldBlock())
+            return;
+
+        if (sent <= 0)
+        {
+            connection.failed = true;
+            connection.output.clear();
+            return;
+        }
+
+        connection.output.erase(0, sent);
+        connection.lastActivity = std::chrono::steady_clock::now();
+    }
+}
+
+void MatchServer::DispatchJob(SocketHandle client, Connection& connection)
+{
+    size_t lastLineEnd = connection.input.rfind('\n');
+    if (lastLineEnd == std::string::npos)
+        return;
+
+    /* Every complete request received so far goes into one job, answered in order and sent back together. */
+    Job job{ client, {}, {} };
+    size_t lineStart = 0;
+    for (size_t lineEnd; lineStart <= lastLineEnd && (lineEnd = connection.input.find('\n', lineStart)) != std::string::npos; lineStart = lineEnd + 1)
+    {
+        std::string request = connection.input.substr(lineStart, lineEnd - lineStart);
+        if (!request.empty() && request.back() == '\r')
+            request.pop_back();
+
+        job.requests.push_back(std::move(request));
+    }
+    connection.input.erase(0, lastLineEnd + 1);
+    connection.busy = true;
+
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        pendingJobs.push(std::move(job));
+    }
+    jobsCondition.notify_one();
+}
+
+void MatchServer::CollectResults()
+{
+    std::vector<Job> results;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        results.swap(completedJobs);
+    }
+
+    /* A connection is closed only when it has no job in the pool, so its socket cannot have been reused meanwhile. */
+    for (Job& result : results)
+    {
+        Connection& connection = connections[result.client];
+        connection.busy = false;
+        if (connection.failed)
+            continue;
+
+        connection.output += result.responses;
+        WriteClient(result.client, connection);
+    }
+}
+
+void MatchServer::CloseConnections()
+{
+    for (const auto& [client, connection] : connections)
+        CloseSocket(client);
+    connections.clear();
+
+    for (SocketHandle* socket : { &wakeSender, &wakeReceiver, &listener })
+        if (*socket != InvalidSocket)
+        {
+            CloseSocket(*socket);
+            *socket = InvalidSocket;
+        }
+
+    std::error_code error;
+    std::filesystem::remove(socketPath, error);
+}
+
+std::string MatchServer::HandleRequest(const std::string& request)
+{
+    std::istringstream stream(request);
+    std::string command, id;
+    stream >> command >> id;
+
+    if (id.empty())
+        return "ERR Cerere invalida";
+
+    if (command == "COMPILE")
+    {
+        std::string regex;
+        stream >> regex;
+        return Compile(id, regex);
+    }
+
+    if (command == "MATCH" || command == "BATCH")
+    {
+        std::vector<std::string> words;
+        for (std::string text, word; stream >> text; words.push_back(word))
+            if (!UnescapeWord(text, word))
+                return "ERR Cerere invalida";
+
+        if (words.empty() || (command == "MATCH" && words.size() != 1))
+            return "ERR Cerere invalida";
+
+        return Match(id, words);
+    }
+
+    if (command == "DROP")
+        return Drop(id);
+
+    if (command == "ADDRULE" || command == "REMOVERULE")
+    {
+        std::string ruleId, regex;
+        stream >> ruleId >> regex;
+        return UpdateRules(command, id, ruleId, regex);
+    }
+
+    if (command == "MATCHRULES")
+    {
+        /* Exactly one word, as for MATCH. */
+        std::string text, extra, word;
+        stream >> text >> extra;
+        if (text.empty() || !extra.empty() || !UnescapeWord(text, word))
+            return "ERR Cerere invalida";
+
+        return MatchRules(id, word);
+    }
+
+    if (command == "EQUIV" || command == "SUBSET")
+    {
+        std::string otherId;
+        stream >> otherId;
+        return Compare(command, id, otherId);
+    }
+
+    return "ERR Comanda necunoscuta: " + command;
+}
+
+std::string MatchServer::Compile(const std::string& id, const std::string& regex)
+{
+    std::ostringstream errors;
+    if (!DeterministicFiniteAutomaton::IsValidRegex(regex, errors))
+    {
+        std::string message = errors.str();
+        while (!message.empty() && (message.back() == '\n' || message.back() == '.'))
+            message.pop_back();
+        return "ERR " + message;
+    }
+
+    /* The automaton is built outside the lock, so a long compilation does not hold up the other requests. */
+    /* Only the compressed form is kept; the DFA is dropped as soon as it has been packed. */
+    std::shared_ptr<const CompressedAutomaton> automaton;
+    try
+    {
+        automaton = std::make_shared<const CompressedAutomaton>(
+            DeterministicFiniteAutomaton::BuildDFA(DeterministicFiniteAutomaton::ConvertToPostfix(regex)).Compress());
+    }
+    catch (const std::length_error& error)
+    {
+        return "ERR " + std::string(error.what());
+    }
+
+    std::unique_lock<std::shared_mutex> lock(registryMutex);
+    registry[id] = std::move(automaton);
+
+    return "OK " + id;
+}
+
+std::string MatchServer::Match(const std::string& id, const std::vector<std::string>& words) const
+{
+    std::shared_ptr<const CompressedAutomaton> automaton = FindAutomaton(id);
+    if (!automaton)
+        return "ERR Automat inexistent: " + id;
+
+    std::string response = "OK ";
+    for (const std::string& word : words)
+        response += automaton->AcceptsWord(word) ? '1' : '0';
+
+    return response;
+}
+
+std::string MatchServer::Drop(const std::string& id)
+{
+    std::unique_lock<std::shared_mutex> lock(registryMutex);
+    if (registry.erase(id) == 0)
+        return "ERR Automat inexistent: " + id;
+
+    return "OK " + id;
+}
+
+std::string MatchServer::Compare(const std::string& command, const std::string& id, const std::string& otherId) const
+{
+    std::shared_ptr<const CompressedAutomaton> automaton = FindAutomaton(id);
+    if (!automaton)
+        return "ERR Automat inexistent: " + id;
+
+    std::shared_ptr<const CompressedAutomaton> otherAutomaton = FindAutomaton(otherId);
+    if (!otherAutomaton)
+        return "ERR Automat inexistent: " + otherId;
+
+    std::string counterexample;
+    bool holds = command == "EQUIV" ? automaton->IsEquivalentTo(*otherAutomaton, counterexample)
+        : automaton->IsIncludedIn(*otherAutomaton, counterexample);
+
+    if (holds)
+        return "OK 1";
+
+    return "OK 0 " + EscapeWord(counterexample);
+}
+
+std::string MatchServer::UpdateRules(const std::string& command, const std::string& setId, const std::string& ruleId, const std::string& regex)
+{
+    if (ruleId.empty())
+        return "ERR Cerere invalida";
+
+    std::shared_ptr<RuleSet> ruleSet;
+    {
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        if (auto it = ruleSets.find(setId); it != ruleSets.end())
+            ruleSet = it->second;
+    }
+
+    /* The rule set rebuilds and publishes on its own, while MATCHRULES requests keep using the previous snapshot. */
+    if (command == "REMOVERULE")
+    {
+        if (!ruleSet)
+            return "ERR Set de reguli inexistent: " + setId;
+        return ruleSet->RemoveRule(ruleId) ? "OK " + ruleId : "ERR Regula inexistenta: " + ruleId;
+    }
+
+    std::ostringstream errors;
+    bool added = false;
+    if (ruleSet)
+        added = ruleSet->AddRule(ruleId, regex, errors);
+    else
+    {
+        /* ADDRULE creates the set on its first rule, but registers it only once that rule is in, so a rejected rule
+           leaves no empty set behind. If another request registered the set meanwhile, the rule goes into that one. */
+        auto newSet = std::make_shared<RuleSet>();
+        added = newSet->AddRule(ruleId, regex, errors);
+        if (added)
+        {
+            std::unique_lock<std::shared_mutex> lock(registryMutex);
+            auto [it, inserted] = ruleSets.insert({ setId, newSet });
+            if (!inserted)
+                ruleSet = it->second;
+        }
+
+        if (ruleSet)
+            added = ruleSet->AddRule(ruleId, regex, errors);
+    }
+
+    if (!added)
+    {
+        std::string message = errors.str();
+        while (!message.empty() && (message.back() == '\n' || message.back() == '.'))
+            message.pop_back();
+        return "ERR " + message;
+    }
+
+    return "OK " + ruleId;
+}
+
+std::string MatchServer::MatchRules(const std::string& setId, const std::string& word) const
+{
+    std::shared_ptr<RuleSet> ruleSet;
+    {
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        if (auto it = ruleSets.find(setId); it != ruleSets.end())
+            ruleSet = it->second;
+    }
+
+    if (!ruleSet)
+        return "ERR Set de reguli inexistent: " + setId;
+
+    std::string response = "OK";
+    for (const std::string& ruleId : ruleSet->Match(word))
+        response += " " + ruleId;
+
+    return response;
+}
+
+std::shared_ptr<const CompressedAutomaton> MatchServer::FindAutomaton(const std::string& id) const
+{
+    std::shared_lock<std::shared_mutex> lock(registryMutex);
+    if (auto it = registry.find(id); it != registry.end())
+        return it->second;
+
+    return nullptr;
+}
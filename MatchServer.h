@@ -0,0 +1,113 @@
+﻿#pragma once
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <queue>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "DeterministicFiniteAutomaton.h"
+#include "RuleSet.h"
+
+#ifdef _WIN32
+using SocketHandle = std::uintptr_t;
+#else
+using SocketHandle = int;
+#endif
+
+/* Resident service that keeps compiled automata in memory and answers requests on a local (AF_UNIX) socket.
+   Protocol: one request per line, one response per line, in the same order (clients may pipeline requests):
+     COMPILE <id> <regex>      -> OK <id>
+     MATCH <id> <cuvant>       -> OK 1 | OK 0
+     BATCH <id> <cuvant>...    -> OK <un bit 1/0 pentru fiecare cuvant>
+     DROP <id>                 -> OK <id>
+     EQUIV <id1> <id2>         -> OK 1 | OK 0 <cuvant acceptat de unul singur>
+     SUBSET <id1> <id2>        -> OK 1 | OK 0 <cuvant acceptat de id1, respins de id2>
+     ADDRULE <set> <id> <regex> -> OK <id>
+     REMOVERULE <set> <id>     -> OK <id>
+     MATCHRULES <set> <cuvant> -> OK <id-urile regulilor care accepta cuvantul>
+   Words, in requests and in the counterexamples of EQUIV and SUBSET, are single tokens: a byte may be written as \xHH,
+   and the server writes that way every byte that is not printable ASCII, \ and $. A lone $ is the empty word and \x24
+   a literal $. Any failure is answered with ERR <mesaj>.
+   All the sockets are watched by the thread that calls Run; the complete lines of a connection are handed to the pool
+   as one job, and the next job of that connection is started only after the previous one was answered. */
+class MatchServer
+{
+public:
+    MatchServer(const std::string& socketPath = "regex.sock", unsigned threadsNumber = std::thread::hardware_concurrency());
+    ~MatchServer();
+
+    bool Run();
+    void Stop();
+
+    std::string HandleRequest(const std::string& request);
+
+private:
+    struct Connection
+    {
+        std::string input;
+        std::string output;
+        bool busy = false;
+        bool inputClosed = false;
+        bool tooLong = false;
+        bool discarding = false;
+        bool failed = false;
+        std::chrono::steady_clock::time_point lastActivity;
+    };
+
+    struct Job
+    {
+        SocketHandle client;
+        std::vector<std::string> requests;
+        std::string responses;
+    };
+
+    void WorkerLoop();
+    void Wake();
+    void AcceptClients();
+    void ReadClient(SocketHandle client, Connection& connection);
+    void WriteClient(SocketHandle client, Connection& connection);
+    void DispatchJob(SocketHandle client, Connection& connection);
+    void CollectResults();
+    void CloseConnections();
+
+    std::string Compile(const std::string& id, const std::string& regex);
+    std::string Match(const std::string& id, const std::vector<std::string>& words) const;
+    std::string Drop(const std::string& id);
+    std::string Compare(const std::string& command, const std::string& id, const std::string& otherId) const;
+    std::string UpdateRules(const std::string& command, const std::string& setId, const std::string& ruleId, const std::string& regex);
+    std::string MatchRules(const std::string& setId, const std::string& word) const;
+    std::shared_ptr<const CompressedAutomaton> FindAutomaton(const std::string& id) const;
+
+    std::string socketPath;
+    unsigned threadsNumber;
+    SocketHandle listener;
+    std::atomic<bool> running;
+    /* Set by every Stop, so a stop that comes before Run has started listening is not lost. */
+    std::atomic<bool> stopRequested;
+
+    /* Stop and the workers write a byte to wakeSender, so the poll in Run returns on wakeReceiver. */
+    SocketHandle wakeSender;
+    SocketHandle wakeReceiver;
+
+    std::unordered_map<std::string, std::shared_ptr<const CompressedAutomaton>> registry;
+    std::unordered_map<std::string, std::shared_ptr<RuleSet>> ruleSets;
+    mutable std::shared_mutex registryMutex;
+
+    /* Only the thread that calls Run touches the connections. */
+    std::unordered_map<SocketHandle, Connection> connections;
+    std::chrono::steady_clock::time_point acceptPausedUntil;
+
+    std::queue<Job> pendingJobs;
+    std::vector<Job> completedJobs;
+    bool workersRunning;
+    std::mutex jobsMutex;
+    std::condition_variable jobsCondition;
+    std::vector<std::thread> workers;
+};
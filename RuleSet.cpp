@@ -0,0 +1,277 @@
+﻿#include "RuleSet.h"
+
+/* Rule automaton transitions: not yet determinized, or to the dead state (the empty subset). */
+static const int UnknownState = -2;
+static const int DeadState = -1;
+
+RuleSet::RuleAutomaton::RuleAutomaton(const LambdaNondeterministicAutomaton& lambdaAutomaton)
+    : lambdaAutomaton(lambdaAutomaton)
+{
+    FindOrAddSubset(lambdaAutomaton.FindLambdaClosure({ lambdaAutomaton.GetInitialState() }));
+}
+
+int RuleSet::RuleAutomaton::Next(int state, char symbol)
+{
+    if (state == DeadState)
+        return DeadState;
+
+    if (int target = transitions[state][(unsigned char)symbol]; target != UnknownState)
+        return target;
+
+    std::unordered_set<std::string> subset = lambdaAutomaton.FindLambdaClosure(lambdaAutomaton.FindTransition(subsets[state], symbol));
+    int target = subset.empty() ? DeadState : FindOrAddSubset(subset);
+    transitions[state][(unsigned char)symbol] = target;
+
+    return target;
+}
+
+bool RuleSet::RuleAutomaton::IsFinal(int state) const
+{
+    return state != DeadState && finalStates[state];
+}
+
+const std::unordered_set<char>& RuleSet::RuleAutomaton::GetAlphabet() const
+{
+    return lambdaAutomaton.GetAlphabet();
+}
+
+int RuleSet::RuleAutomaton::FindOrAddSubset(const std::unordered_set<std::string>& subset)
+{
+    auto [it, inserted] = subsetsIndex.insert({ std::set<std::string>(subset.begin(), subset.end()), (int)subsets.size() });
+    if (!inserted)
+        return it->second;
+
+    subsets.push_back(subset);
+    transitions.emplace_back();
+    transitions.back().fill(UnknownState);
+
+    bool isFinal = false;
+    for (const std::string& state : subset)
+        if (lambdaAutomaton.GetFinalStates().contains(state))
+            isFinal = true;
+    finalStates.push_back(isFinal);
+
+    return it->second;
+}
+
+RuleSet::RuleSet()
+    : nextSlot(0), productIndex({ { ProductState(), 0 } }), productStates(1), productRows(1), initialState(0)
+{
+    /* With no rules the combined automaton is a single state without transitions. */
+    Publish();
+}
+
+bool RuleSet::AddRule(const std::string& id, const std::string& regex, std::ostream& os)
+{
+    if (!DeterministicFiniteAutomaton::IsValidRegex(regex, os))
+        return false;
+
+    LambdaNondeterministicAutomaton lambdaAutomaton(DeterministicFiniteAutomaton::ConvertToPostfix(regex));
+    RuleAutomaton automaton(lambdaAutomaton);
+
+    std::lock_guard<std::mutex> lock(rulesMutex);
+    const int slot = nextSlot++;
+    rules.emplace(slot, Rule{ id, std::move(automaton) });
+
+    /* The new rule is dead in every existing product state, so those keep their transitions; only the states reached
+       while it is alive, starting from the new initial state, are explored. */
+    std::queue<int> unexplored;
+    ProductState initialProductState = productStates[initialState];
+    initialProductState.push_back({ slot, 0 });
+    initialState = FindOrAddProductState(initialProductState, unexplored);
+    if (!ExploreProductStates(unexplored))
+    {
+        /* Every state reached so far projects onto a state that was already complete, so removing the new slot gives back
+           the previous product; the published snapshot was never replaced. */
+        RemoveSlot(slot);
+        os << "Automat prea mare: depaseste " << DeterministicFiniteAutomaton::MaxStatesNumber << " de stari.\n";
+        return false;
+    }
+
+    /* A rule with the same id is replaced only once its successor is in place, so a failed replacement keeps it. */
+    if (auto slotIt = slots.find(id); slotIt != slots.end())
+        RemoveSlot(slotIt->second);
+    slots[id] = slot;
+
+    Publish();
+
+    return true;
+}
+
+bool RuleSet::RemoveRule(const std::string& id)
+{
+    std::lock_guard<std::mutex> lock(rulesMutex);
+    if (!Remove(id))
+        return false;
+
+    Publish();
+
+    return true;
+}
+
+std::vector<std::string> RuleSet::Match(const std::string& word) const
+{
+    std::shared_ptr<const Snapshot> current = GetSnapshot();
+
+    const int deadState = current->transitions.GetDeadState();
+    int currentState = current->initialState;
+    for (char symbol : word)
+    {
+        currentState = current->transitions.Next(currentState, (unsigned char)symbol);
+        if (currentState == deadState)
+            return {};
+    }
+
+    return current->acceptingRules[currentState];
+}
+
+std::shared_ptr<const RuleSet::Snapshot> RuleSet::GetSnapshot() const
+{
+    return snapshot.load();
+}
+
+bool RuleSet::Remove(const std::string& id)
+{
+    /* Called with rulesMutex held. */
+    auto slotIt = slots.find(id);
+    if (slotIt == slots.end())
+        return false;
+
+    const int slot = slotIt->second;
+    slots.erase(slotIt);
+    RemoveSlot(slot);
+
+    return true;
+}
+
+void RuleSet::RemoveSlot(int slot)
+{
+    rules.erase(slot);
+
+    auto project = [slot](const ProductState& productState)
+        {
+            ProductState projected;
+            for (const auto& component : productState)
+                if (component.first != slot)
+                    projected.push_back(component);
+            return projected;
+        };
+
+    /* Without the removed rule, states that differed only in its component become one; the states left with no live rule
+       become the dead state (except the initial state, which always exists). */
+    std::map<ProductState, int> mergedIndex;
+    std::vector<int> merged(productStates.size(), DeadState);
+    std::vector<int> representatives;
+    for (int state = 0; state < productStates.size(); state++)
+    {
+        ProductState projected = project(productStates[state]);
+        if (projected.empty() && state != initialState)
+            continue;
+
+        auto [it, inserted] = mergedIndex.insert({ std::move(projected), (int)representatives.size() });
+        if (inserted)
+            representatives.push_back(state);
+        merged[state] = it->second;
+    }
+
+    /* The merged states are renumbered in the order they are reached from the initial state, which also drops the states
+       left unreachable by earlier additions. */
+    std::vector<int> renumbered(representatives.size(), -1);
+    std::vector<int> order = { merged[initialState] };
+    renumbered[order[0]] = 0;
+    for (int k = 0; k < order.size(); k++)
+        for (const auto& [symbol, target] : productRows[representatives[order[k]]])
+            if (int mergedTarget = merged[target]; mergedTarget != DeadState && renumbered[mergedTarget] == -1)
+            {
+                renumbered[mergedTarget] = (int)order.size();
+                order.push_back(mergedTarget);
+            }
+
+    std::vector<ProductState> newStates;
+    std::vector<std::vector<std::pair<unsigned char, int>>> newRows;
+    productIndex.clear();
+    for (int mergedState : order)
+    {
+        const int representative = representatives[mergedState];
+        newStates.push_back(project(productStates[representative]));
+        productIndex.insert({ newStates.back(), (int)newStates.size() - 1 });
+
+        newRows.emplace_back();
+        for (const auto& [symbol, target] : productRows[representative])
+            if (merged[target] != DeadState)
+                newRows.back().push_back({ symbol, renumbered[merged[target]] });
+    }
+
+    productStates = std::move(newStates);
+    productRows = std::move(newRows);
+    initialState = 0;
+}
+
+int RuleSet::FindOrAddProductState(const ProductState& productState, std::queue<int>& unexplored)
+{
+    auto [it, inserted] = productIndex.insert({ productState, (int)productStates.size() });
+    if (inserted)
+    {
+        productStates.push_back(productState);
+        productRows.emplace_back();
+        unexplored.push(it->second);
+    }
+
+    return it->second;
+}
+
+bool RuleSet::ExploreProductStates(std::queue<int>& unexplored)
+{
+    while (!unexplored.empty())
+    {
+        if (productStates.size() > DeterministicFiniteAutomaton::MaxStatesNumber)
+            return false;
+
+        const int current = unexplored.front();
+        unexplored.pop();
+
+        /* Only the symbols of the live rules can lead anywhere. */
+        const ProductState currentState = productStates[current];
+        std::set<char> alphabet;
+        for (const auto& [slot, state] : currentState)
+        {
+            const std::unordered_set<char>& symbols = rules.at(slot).automaton.GetAlphabet();
+            alphabet.insert(symbols.begin(), symbols.end());
+        }
+
+        for (char symbol : alphabet)
+        {
+            ProductState nextState;
+            for (const auto& [slot, state] : currentState)
+                if (int target = rules.at(slot).automaton.Next(state, symbol); target != DeadState)
+                    nextState.push_back({ slot, target });
+
+            if (nextState.empty())
+                continue;
+
+            int target = FindOrAddProductState(nextState, unexplored);
+            productRows[current].push_back({ (unsigned char)symbol, target });
+        }
+    }
+
+    return true;
+}
+
+void RuleSet::Publish()
+{
+    /* Called with rulesMutex held. The product is already built; only the packed table and the accepted rules are made. */
+    auto built = std::make_shared<Snapshot>();
+    built->transitions = CompressedTransitionTable(productRows);
+    built->initialState = initialState;
+    built->acceptingRules.resize(productStates.size() + 1);
+    for (int state = 0; state < productStates.size(); state++)
+    {
+        for (const auto& [slot, ruleState] : productStates[state])
+            if (const Rule& rule = rules.at(slot); rule.automaton.IsFinal(ruleState))
+                built->acceptingRules[state].push_back(rule.id);
+
+        std::sort(built->acceptingRules[state].begin(), built->acceptingRules[state].end());
+    }
+
+    snapshot.store(std::move(built));
+}
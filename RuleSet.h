@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <set>
+#include <queue>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include "DeterministicFiniteAutomaton.h"
+#include "CompressedTransitionTable.h"
+
+/* Several patterns compiled into one automaton that reports which of them accept a word.
+   Each rule keeps its lambda-NFA and its own subset -> DFA state index, determinized lazily and kept between builds.
+   The combined automaton is the product of the rule automata, and it is kept between builds too: a product state lists only
+   the rules that are not in their dead state, so the states built before a rule was added are still exact afterwards and an
+   addition only explores the states where the new rule is alive. A removal drops the rule from every product state, merging
+   the states that differed only there, without stepping any automaton.
+   The product is bounded by DeterministicFiniteAutomaton::MaxStatesNumber; a rule that would exceed it is not added.
+   Every build is published as a new immutable snapshot, swapped atomically, so Match never waits for a rebuild. */
+class RuleSet
+{
+public:
+    struct Snapshot
+    {
+        CompressedTransitionTable transitions;
+        int initialState;
+        std::vector<std::vector<std::string>> acceptingRules;
+    };
+
+    RuleSet();
+
+    bool AddRule(const std::string& id, const std::string& regex, std::ostream& os = std::cout);
+    bool RemoveRule(const std::string& id);
+    std::vector<std::string> Match(const std::string& word) const;
+    std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+private:
+    class RuleAutomaton
+    {
+    public:
+        RuleAutomaton(const LambdaNondeterministicAutomaton& lambdaAutomaton);
+
+        int Next(int state, char symbol);
+        bool IsFinal(int state) const;
+        const std::unordered_set<char>& GetAlphabet() const;
+
+    private:
+        int FindOrAddSubset(const std::unordered_set<std::string>& subset);
+
+        LambdaNondeterministicAutomaton lambdaAutomaton;
+        std::map<std::set<std::string>, int> subsetsIndex;
+        std::vector<std::unordered_set<std::string>> subsets;
+        std::vector<std::array<int, 256>> transitions;
+        std::vector<bool> finalStates;
+    };
+
+    struct Rule
+    {
+        std::string id;
+        RuleAutomaton automaton;
+    };
+
+    /* The (slot, state) pairs of the rules that are not in their dead state, ordered by slot. */
+    using ProductState = std::vector<std::pair<int, int>>;
+
+    bool Remove(const std::string& id);
+    void RemoveSlot(int slot);
+    int FindOrAddProductState(const ProductState& productState, std::queue<int>& unexplored);
+    bool ExploreProductStates(std::queue<int>& unexplored);
+    void Publish();
+
+    /* Every rule gets a new slot when it is added, so the slot of the newest rule is always the last one in a product state. */
+    std::map<std::string, int> slots;
+    std::map<int, Rule> rules;
+    int nextSlot;
+
+    std::map<ProductState, int> productIndex;
+    std::vector<ProductState> productStates;
+    std::vector<std::vector<std::pair<unsigned char, int>>> productRows;
+    int initialState;
+
+    std::mutex rulesMutex;
+    std::atomic<std::shared_ptr<const Snapshot>> snapshot;
+};
@@ -1,5 +1,13 @@
-﻿#include <regex>
-#include "DeterministicFiniteAutomaton.h"
+﻿#include "DeterministicFiniteAutomaton.h"
+#include "MatchServer.h"
+#include <csignal>
+
+static MatchServer* runningServer = nullptr;
+
+static void StopServer(int)
+{
+    runningServer->Stop();
+}
 
 bool readRegex(const std::string& fileName, std::string& regex)
 {
@@ -15,43 +23,47 @@ bool readRegex(const std::string& fileName, std::string& regex)
     return true;
 }
 
-bool isValidRegex(const std::string& regex)
+int main(int argc, char* argv[]) 
 {
-    if (regex.empty())
+    /* Tema1_LFC --server [cale socket] [numar fire]: serveste cereri pe socket in loc de meniul interactiv. */
+    if (argc > 1 && std::string(argv[1]) == "--server")
     {
-        std::cout << "Regex vid.\n";
-        return false;
-    }
-
-    try
-    {
-        std::regex regEx(regex);
-    }
-    catch (const std::regex_error&)
-    {
-        std::cout << "Expresie invalida.\n";
-        return false;
-    }
-
-    for(int i = 0; i < regex.size(); i++)
-        if(!isalnum(regex[i]) && !strchr("().|*+", regex[i]) || 
-            regex[i] == '.' && (i == 0 || i == regex.size()-1 || strchr("*+|", regex[i + 1])))
+        unsigned threadsNumber = std::thread::hardware_concurrency();
+        if (argc > 3)
         {
-            std::cout << "Expresie invalida.\n";
-            return false;
+            std::string threadsText = argv[3];
+            if (threadsText.empty() || threadsText.size() > 3 || threadsText.find_first_not_of("0123456789") != std::string::npos ||
+                std::stoi(threadsText) == 0)
+            {
+                std::cout << "Numar de fire invalid: " << threadsText << "\n";
+                return 1;
+            }
+            threadsNumber = std::stoi(threadsText);
         }
 
-    return true;
-}
+        /* Ctrl+C or kill stops the server cleanly: the connections are closed and the socket file is removed. */
+        MatchServer server(argc > 2 ? argv[2] : "regex.sock", threadsNumber);
+        runningServer = &server;
+        std::signal(SIGINT, StopServer);
+        std::signal(SIGTERM, StopServer);
+
+        return server.Run() ? 0 : 1;
+    }
 
-int main() 
-{
     std::string regex;
 
-    if (readRegex("regex.in", regex) && isValidRegex(regex))
+    if (readRegex("regex.in", regex) && DeterministicFiniteAutomaton::IsValidRegex(regex))
     {
-        DeterministicFiniteAutomaton automaton = DeterministicFiniteAutomaton::BuildDFA(DeterministicFiniteAutomaton::ConvertToPostfix(regex));
-        automaton.RunMenu(regex);
+        try
+        {
+            DeterministicFiniteAutomaton automaton = DeterministicFiniteAutomaton::BuildDFA(DeterministicFiniteAutomaton::ConvertToPostfix(regex));
+            automaton.RunMenu(regex);
+        }
+        catch (const std::length_error& error)
+        {
+            std::cout << error.what() << ".\n";
+            return 1;
+        }
     }
 
     return 0;
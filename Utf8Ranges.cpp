@@ -0,0 +1,204 @@
+﻿#include "Utf8Ranges.h"
+
+#include <algorithm>
+
+bool Utf8Ranges::DecodeCodePoint(const std::string& text, size_t& position, char32_t& codePoint)
+{
+    if (position >= text.size())
+        return false;
+
+    unsigned char lead = text[position];
+    int length;
+    if (lead < 0x80) {
+        codePoint = lead;
+        length = 1;
+    }
+    else if ((lead & 0xE0) == 0xC0) {
+        codePoint = lead & 0x1F;
+        length = 2;
+    }
+    else if ((lead & 0xF0) == 0xE0) {
+        codePoint = lead & 0x0F;
+        length = 3;
+    }
+    else if ((lead & 0xF8) == 0xF0) {
+        codePoint = lead & 0x07;
+        length = 4;
+    }
+    else
+        return false;
+
+    if (position + length > text.size())
+        return false;
+
+    for (int i = 1; i < length; i++) {
+        unsigned char continuation = text[position + i];
+        if ((continuation & 0xC0) != 0x80)
+            return false;
+        codePoint = (codePoint << 6) | (continuation & 0x3F);
+    }
+
+    /* Overlong forms, surrogates and values past U+10FFFF are not valid UTF-8. */
+    static const char32_t minimums[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    if (codePoint < minimums[length] || codePoint > MaxCodePoint || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        return false;
+
+    position += length;
+    return true;
+}
+
+bool Utf8Ranges::ParseCharacterClass(const std::string& classBody, std::vector<CodePointRange>& ranges)
+{
+    /* classBody is the text between [ and ]: characters and ranges such as a-z or α-ω, negated by a leading ^. */
+    ranges.clear();
+
+    size_t position = 0;
+    bool negated = !classBody.empty() && classBody[0] == '^';
+    if (negated)
+        position++;
+
+    if (position == classBody.size())
+        return false;
+
+    while (position < classBody.size()) {
+        char32_t low, high;
+        if (!DecodeCodePoint(classBody, position, low))
+            return false;
+
+        high = low;
+        /* A - between two characters makes a range; as the last character of the class it stands for itself. */
+        if (position + 1 < classBody.size() && classBody[position] == '-') {
+            position++;
+            if (!DecodeCodePoint(classBody, position, high) || high < low)
+                return false;
+        }
+
+        ranges.push_back({ low, high });
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<CodePointRange> mergedRanges;
+    for (const CodePointRange& range : ranges)
+        if (!mergedRanges.empty() && range.first <= mergedRanges.back().second + 1)
+            mergedRanges.back().second = std::max(mergedRanges.back().second, range.second);
+        else
+            mergedRanges.push_back(range);
+
+    if (negated) {
+        std::vector<CodePointRange> complement;
+        char32_t next = 0;
+        for (const CodePointRange& range : mergedRanges) {
+            if (next < range.first)
+                complement.push_back({ next, range.first - 1 });
+            next = range.second + 1;
+        }
+        if (next <= MaxCodePoint)
+            complement.push_back({ next, MaxCodePoint });
+        mergedRanges = complement;
+    }
+
+    /* U+0000 would be taken for a lambda-transition and surrogates have no UTF-8 encoding, so both are left out. */
+    ranges.clear();
+    for (CodePointRange range : mergedRanges) {
+        range.first = std::max<char32_t>(range.first, 1);
+        if (range.first <= 0xDFFF && range.second >= 0xD800) {
+            if (range.first < 0xD800)
+                ranges.push_back({ range.first, 0xD7FF });
+            range.first = 0xE000;
+        }
+        if (range.first <= range.second)
+            ranges.push_back(range);
+    }
+
+    return !ranges.empty();
+}
+
+std::vector<std::vector<Utf8Ranges::ByteRange>> Utf8Ranges::ToByteSequences(const std::vector<CodePointRange>& ranges)
+{
+    std::vector<std::vector<ByteRange>> sequences;
+    for (const CodePointRange& range : ranges)
+        SplitRange(range.first, range.second, sequences);
+
+    return sequences;
+}
+
+std::string Utf8Ranges::FormatSymbol(char symbol)
+{
+    if (symbol == '\0')
+        return "$";
+
+    /* Bytes that are not printable ASCII (parts of UTF-8 characters, control characters) are shown as \xHH. */
+    unsigned char byte = symbol;
+    if (byte > 0x20 && byte < 0x7F)
+        return std::string(1, symbol);
+
+    static const char digits[] = "0123456789ABCDEF";
+    return std::string("\\x") + digits[byte >> 4] + digits[byte & 0xF];
+}
+
+void Utf8Ranges::SplitRange(char32_t low, char32_t high, std::vector<std::vector<ByteRange>>& sequences)
+{
+    if (low > high)
+        return;
+
+    /* First at the code points where the encoded length changes... */
+    for (char32_t boundary : { 0x7F, 0x7FF, 0xFFFF })
+        if (low <= boundary && boundary < high) {
+            SplitRange(low, boundary, sequences);
+            SplitRange(boundary + 1, high, sequences);
+            return;
+        }
+
+    if (high <= 0x7F) {
+        sequences.push_back({ { (unsigned char)low, (unsigned char)high } });
+        return;
+    }
+
+    /* ...then until each part covers whole blocks of continuation bytes, so it is exactly a product of byte ranges. */
+    for (int i = 1; i < 4; i++) {
+        char32_t mask = (1u << (6 * i)) - 1;
+        if ((low & ~mask) != (high & ~mask)) {
+            if ((low & mask) != 0) {
+                SplitRange(low, low | mask, sequences);
+                SplitRange((low | mask) + 1, high, sequences);
+                return;
+            }
+            if ((high & mask) != mask) {
+                SplitRange(low, (high & ~mask) - 1, sequences);
+                SplitRange(high & ~mask, high, sequences);
+                return;
+            }
+        }
+    }
+
+    std::string lowBytes = Encode(low), highBytes = Encode(high);
+    std::vector<ByteRange> sequence;
+    for (size_t i = 0; i < lowBytes.size(); i++)
+        sequence.push_back({ (unsigned char)lowBytes[i], (unsigned char)highBytes[i] });
+
+    sequences.push_back(sequence);
+}
+
+std::string Utf8Ranges::Encode(char32_t codePoint)
+{
+    std::string bytes;
+    if (codePoint < 0x80)
+        bytes += (char)codePoint;
+    else if (codePoint < 0x800) {
+        bytes += (char)(0xC0 | (codePoint >> 6));
+        bytes += (char)(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000) {
+        bytes += (char)(0xE0 | (codePoint >> 12));
+        bytes += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        bytes += (char)(0x80 | (codePoint & 0x3F));
+    }
+    else {
+        bytes += (char)(0xF0 | (codePoint >> 18));
+        bytes += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+        bytes += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        bytes += (char)(0x80 | (codePoint & 0x3F));
+    }
+
+    return bytes;
+}
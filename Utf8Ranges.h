@@ -0,0 +1,25 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+/* Helpers for compiling Unicode character classes into byte-level automata: a set of code point ranges is rewritten
+   as UTF-8 byte sequences, each position being a range of bytes, so the matcher never has to decode its input. */
+class Utf8Ranges
+{
+public:
+    using CodePointRange = std::pair<char32_t, char32_t>;
+    using ByteRange = std::pair<unsigned char, unsigned char>;
+
+    static bool DecodeCodePoint(const std::string& text, size_t& position, char32_t& codePoint);
+    static bool ParseCharacterClass(const std::string& classBody, std::vector<CodePointRange>& ranges);
+    static std::vector<std::vector<ByteRange>> ToByteSequences(const std::vector<CodePointRange>& ranges);
+    static std::string FormatSymbol(char symbol);
+
+    static constexpr char32_t MaxCodePoint = 0x10FFFF;
+
+private:
+    static void SplitRange(char32_t low, char32_t high, std::vector<std::vector<ByteRange>>& sequences);
+    static std::string Encode(char32_t codePoint);
+};
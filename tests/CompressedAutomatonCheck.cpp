@@ -0,0 +1,78 @@
+﻿/* Standalone check: the compressed form of random automata must accept exactly the words the DFA accepts, and be
+   equivalent to (and included in) the compressed form of the same DFA.
+   Build from the repository root, for example:
+     g++ -std=c++20 -I. tests/CompressedAutomatonCheck.cpp CompressedAutomaton.cpp CompressedTransitionTable.cpp
+         DeterministicFiniteAutomaton.cpp LambdaNondeterministicAutomaton.cpp Utf8Ranges.cpp -o CompressedAutomatonCheck
+   It prints every mismatch and exits with 1 if there was any. */
+#include "DeterministicFiniteAutomaton.h"
+#include <random>
+
+static std::string RandomRegex(std::mt19937& generator)
+{
+    static const char* pieces[] = { "a", "b", "c", "[a-c]", "[^a]", "α", "[α-ω]", "[b-z]" };
+    const int piecesNumber = sizeof(pieces) / sizeof(pieces[0]);
+
+    std::string regex = pieces[generator() % piecesNumber];
+    for (int k = generator() % 5; k > 0; k--)
+    {
+        std::string piece = pieces[generator() % piecesNumber];
+        switch (generator() % 5)
+        {
+        case 0: regex = "(" + regex + "|" + piece + ")"; break;
+        case 1: regex = "(" + regex + ")*"; break;
+        case 2: regex = regex + "." + piece; break;
+        case 3: regex = "(" + regex + "){1,3}"; break;
+        default: regex = regex + "." + piece + "+"; break;
+        }
+    }
+
+    return regex;
+}
+
+static std::string RandomWord(std::mt19937& generator)
+{
+    /* ASCII letters, the bytes of α and ω, and bytes that no expression uses. */
+    static const std::string bytes = "abcz\xce\xb1\xcf\x89\xff\x01";
+
+    std::string word;
+    for (int length = generator() % 8; length > 0; length--)
+        word += bytes[generator() % bytes.size()];
+
+    return word;
+}
+
+int main()
+{
+    std::mt19937 generator(7);
+    int mismatches = 0;
+
+    for (int test = 0; test < 300; test++)
+    {
+        std::string regex = RandomRegex(generator);
+        if (!DeterministicFiniteAutomaton::IsValidRegex(regex, std::cerr))
+            continue;
+
+        DeterministicFiniteAutomaton automaton = DeterministicFiniteAutomaton::BuildDFA(DeterministicFiniteAutomaton::ConvertToPostfix(regex));
+        CompressedAutomaton compressed = automaton.Compress();
+
+        for (int i = 0; i < 300; i++)
+        {
+            std::string word = RandomWord(generator);
+            if (automaton.AcceptsWord(word) != compressed.AcceptsWord(word))
+            {
+                std::cout << "AcceptsWord difera pentru " << regex << " pe cuvantul de " << word.size() << " octeti\n";
+                mismatches++;
+            }
+        }
+
+        std::string counterexample;
+        if (!compressed.IsEquivalentTo(automaton.Compress(), counterexample) || !compressed.IsIncludedIn(automaton.Compress(), counterexample))
+        {
+            std::cout << "Forma compresata a lui " << regex << " nu este echivalenta cu ea insasi\n";
+            mismatches++;
+        }
+    }
+
+    std::cout << (mismatches == 0 ? "OK\n" : "Diferente: " + std::to_string(mismatches) + "\n");
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+﻿/* Standalone check: after every random ADDRULE/REMOVERULE step, RuleSet::Match must report exactly the rules whose own
+   DFA accepts the word. Replacing a rule and rejected rules (invalid, or past the state bound) are exercised too.
+   Build from the repository root, for example:
+     g++ -std=c++20 -pthread -I. tests/RuleSetCheck.cpp RuleSet.cpp CompressedAutomaton.cpp CompressedTransitionTable.cpp
+         DeterministicFiniteAutomaton.cpp LambdaNondeterministicAutomaton.cpp Utf8Ranges.cpp -o RuleSetCheck
+   It prints every mismatch and exits with 1 if there was any. */
+#include "RuleSet.h"
+#include <random>
+#include <sstream>
+
+static std::string RandomRegex(std::mt19937& generator)
+{
+    static const char* pieces[] = { "a", "b", "c", "d", "[a-c]", "[^a]", "α", "[α-ω]" };
+    const int piecesNumber = sizeof(pieces) / sizeof(pieces[0]);
+
+    /* Now and then a rule the set has to reject. */
+    switch (generator() % 20)
+    {
+    case 0: return "(a|";
+    case 1: return "(a|b)*.a.(a|b){14}";
+    }
+
+    std::string regex = pieces[generator() % piecesNumber];
+    for (int k = generator() % 4; k > 0; k--)
+    {
+        std::string piece = pieces[generator() % piecesNumber];
+        switch (generator() % 4)
+        {
+        case 0: regex = "(" + regex + "|" + piece + ")"; break;
+        case 1: regex = "(" + regex + ")*"; break;
+        case 2: regex = regex + "." + piece; break;
+        default: regex = "(" + regex + "){1,2}"; break;
+        }
+    }
+
+    return regex;
+}
+
+static std::string RandomWord(std::mt19937& generator)
+{
+    static const std::string bytes = "abcdz\xce\xb1\xcf\x89";
+
+    std::string word;
+    for (int length = generator() % 6; length > 0; length--)
+        word += bytes[generator() % bytes.size()];
+
+    return word;
+}
+
+int main()
+{
+    std::mt19937 generator(11);
+    RuleSet ruleSet;
+    /* The rules the set should hold, each with its own DFA; ordered by id, like the answer of Match. */
+    std::map<std::string, DeterministicFiniteAutomaton> expectedRules;
+    int mismatches = 0;
+
+    for (int step = 0; step < 400; step++)
+    {
+        std::string id = "r" + std::to_string(generator() % 30);
+        if (generator() % 3 == 0)
+        {
+            if (ruleSet.RemoveRule(id) != (expectedRules.erase(id) == 1))
+            {
+                std::cout << "RemoveRule " << id << " a raspuns gresit la pasul " << step << "\n";
+                mismatches++;
+            }
+        }
+        else
+        {
+            std::string regex = RandomRegex(generator);
+            std::ostringstream errors;
+            if (ruleSet.AddRule(id, regex, errors))
+                expectedRules.insert_or_assign(id, DeterministicFiniteAutomaton::BuildDFA(DeterministicFiniteAutomaton::ConvertToPostfix(regex)));
+        }
+
+        for (int i = 0; i < 50; i++)
+        {
+            std::string word = RandomWord(generator);
+            std::vector<std::string> expected;
+            for (const auto& [ruleId, automaton] : expectedRules)
+                if (automaton.AcceptsWord(word))
+                    expected.push_back(ruleId);
+
+            if (ruleSet.Match(word) != expected)
+            {
+                std::cout << "Match difera la pasul " << step << " pe cuvantul de " << word.size() << " octeti\n";
+                mismatches++;
+            }
+        }
+    }
+
+    std::cout << (mismatches == 0 ? "OK\n" : "Diferente: " + std::to_string(mismatches) + "\n");
+    return mismatches == 0 ? 0 : 1;
+}